@@ -1,7 +1,11 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <threads.h>
+#include <time.h>
 #include "uri.h"
+#include "uri_filter.h"
+#include "uri_stats.h"
 
 // Генерация массива URI
 const char *uriArray[22] = {
@@ -29,7 +33,372 @@ const char *uriArray[22] = {
         "https://example20.com:1234"
 };
 
+/**
+ * @brief Prints a message if a check fails.
+ *
+ * @param condition Checked condition.
+ * @param what Description of the check.
+ * @return int 0 if the condition holds, 1 otherwise.
+ *
+ * @brief Печатает сообщение, если проверка не прошла.
+ *
+ * @param condition Проверяемое условие.
+ * @param what Описание проверки.
+ * @return int 0 если условие выполнено, иначе 1.
+ */
+static int check(int condition, const char *what) {
+    if (!condition) {
+        printf("Check failed: %s\n", what);
+    }
+    return !condition;
+}
+
+/**
+ * @brief Checks that a JSON document has balanced brackets and quotes.
+ *
+ * @param text JSON text.
+ * @return int 1 if well-formed, 0 otherwise.
+ *
+ * @brief Проверяет, что в JSON-документе сбалансированы скобки и кавычки.
+ *
+ * @param text Текст JSON.
+ * @return int 1 если документ корректен, иначе 0.
+ */
+static int jsonBalanced(const char *text) {
+    char stack[64];
+    size_t depth = 0;
+    int inString = 0;
+    if (*text != '{') {
+        return 0;
+    }
+    for (const char *c = text; *c; ++c) {
+        if (inString) {
+            inString = *c != '"';
+        } else if (*c == '"') {
+            inString = 1;
+        } else if (*c == '{' || *c == '[') {
+            if (depth == sizeof(stack)) {
+                return 0;
+            }
+            stack[depth++] = *c == '{' ? '}' : ']';
+        } else if (*c == '}' || *c == ']') {
+            if (depth == 0 || stack[--depth] != *c) {
+                return 0;
+            }
+            if (depth == 0 && strcmp(c + 1, "\n") != 0) {
+                return 0;
+            }
+        }
+    }
+    return depth == 0 && !inString;
+}
+
+/**
+ * @brief Checks that a URI matches exactly the expected filter rules.
+ *
+ * @param filter Pointer to the filter.
+ * @param uriString URI string.
+ * @param expected Expected rule identifiers, in any order.
+ * @param expectedCount Number of expected identifiers.
+ * @return int 0 on success, 1 on failure.
+ *
+ * @brief Проверяет, что URI совпадает ровно с ожидаемыми правилами фильтра.
+ *
+ * @param filter Указатель на фильтр.
+ * @param uriString Строка URI.
+ * @param expected Ожидаемые идентификаторы правил, в любом порядке.
+ * @param expectedCount Количество ожидаемых идентификаторов.
+ * @return int 0 при успешном выполнении, 1 при ошибке.
+ */
+static int expectMatches(const struct UriFilter *filter, const char *uriString, const size_t *expected, size_t expectedCount) {
+    struct Uri *uri = uriCreate(uriString);
+    if (uri == nullptr) {
+        printf("Check failed: filter: cannot parse %s\n", uriString);
+        return 1;
+    }
+
+    struct UriFilterScratch *scratch = uriFilterScratchCreate(filter);
+    size_t matches[16];
+    size_t count = uriFilterMatch(filter, uri, scratch, matches, 16);
+    uriFilterScratchDestroy(scratch);
+    uriDestroy(uri);
+
+    int same = count == expectedCount;
+    for (size_t i = 0; i < expectedCount && same; ++i) {
+        int found = 0;
+        for (size_t j = 0; j < count; ++j) {
+            found |= matches[j] == expected[i];
+        }
+        same = found;
+    }
+    if (!same) {
+        printf("Check failed: filter: unexpected matches for %s\n", uriString);
+    }
+    return !same;
+}
+
+/**
+ * @brief Tests the URI filter.
+ *
+ * @return int 0 on success, 1 on failure.
+ *
+ * @brief Тестирует фильтр URI.
+ *
+ * @return int 0 при успешном выполнении, 1 при ошибке.
+ */
+static int testFilter(void) {
+    int failed = 0;
+    const struct UriFilterRule rules[] = {
+            {URI_FILTER_HOST_SUFFIX, "example.com"},   // 0
+            {URI_FILTER_HOST_SUFFIX, "evil.org."},     // 1
+            {URI_FILTER_PATH_CONTAINS, "he"},          // 2
+            {URI_FILTER_PATH_CONTAINS, "she"},         // 3
+            {URI_FILTER_PATH_CONTAINS, "hers"},        // 4
+            {URI_FILTER_PATH_CONTAINS, "aab"},         // 5
+            {URI_FILTER_PATH_CONTAINS, "ab"},          // 6
+            {URI_FILTER_QUERY_KEY, "k"},               // 7
+            {URI_FILTER_PATH_PREFIX, "/admin/"},       // 8
+            {URI_FILTER_PATH_PREFIX, "/admin"}         // 9
+    };
+    struct UriFilter *filter = uriFilterCreate(rules, sizeof(rules) / sizeof(rules[0]));
+    if (filter == nullptr) {
+        return check(0, "filter: created");
+    }
+
+    // Host suffixes: label boundary, case folding, trailing dots
+    // Суффиксы хоста: граница метки, регистр, завершающие точки
+    failed |= expectMatches(filter, "http://badexample.com/", nullptr, 0);
+    failed |= expectMatches(filter, "http://example.com/", (const size_t[]){0}, 1);
+    failed |= expectMatches(filter, "http://WWW.EXAMPLE.COM/", (const size_t[]){0}, 1);
+    failed |= expectMatches(filter, "http://example.com./", (const size_t[]){0}, 1);
+    failed |= expectMatches(filter, "http://evil.org/", (const size_t[]){1}, 1);
+    failed |= expectMatches(filter, "http://a.evil.org./", (const size_t[]){1}, 1);
+
+    // Overlapping substrings and duplicates / Перекрывающиеся подстроки и повторы
+    failed |= expectMatches(filter, "http://h/ushers", (const size_t[]){2, 3, 4}, 3);
+    failed |= expectMatches(filter, "http://h/aaab", (const size_t[]){5, 6}, 2);
+    failed |= expectMatches(filter, "http://h/hehe", (const size_t[]){2}, 1);
+
+    // Path prefixes / Префиксы пути
+    failed |= expectMatches(filter, "http://h/admin/x", (const size_t[]){8, 9}, 2);
+    failed |= expectMatches(filter, "http://h/administrator", (const size_t[]){9}, 1);
+    failed |= expectMatches(filter, "http://h/x/admin/", nullptr, 0);
+
+    // Query keys match exactly / Ключи запроса совпадают точно
+    failed |= expectMatches(filter, "http://h/?kx=1", nullptr, 0);
+    failed |= expectMatches(filter, "http://h/?x=k", nullptr, 0);
+    failed |= expectMatches(filter, "http://h/?a=1&k", (const size_t[]){7}, 1);
+    failed |= expectMatches(filter, "http://h/?k=1&k=2", (const size_t[]){7}, 1);
+
+    // Stop at maxMatches, reuse scratch across calls / Остановка на maxMatches, повторное использование рабочей области
+    struct UriFilterScratch *scratch = uriFilterScratchCreate(filter);
+    struct Uri *uri = uriCreate("http://h/ushers");
+    size_t matches[3] = {0};
+    failed |= check(uriFilterMatch(filter, uri, scratch, matches, 2) == 2 && matches[0] != matches[1], "filter: stops at maxMatches");
+    failed |= check(uriFilterMatch(filter, uri, scratch, matches, 1) == 1, "filter: any-match query");
+    failed |= check(uriFilterMatch(filter, uri, scratch, matches, 0) == 0, "filter: zero capacity");
+    failed |= check(uriFilterMatch(filter, uri, scratch, matches, 3) == 3, "filter: scratch reused");
+    failed |= check(uriFilterMatch(filter, uri, nullptr, matches, 3) == 0, "filter: scratch required");
+    uriDestroy(uri);
+    uriFilterScratchDestroy(scratch);
+    uriFilterDestroy(filter);
+
+    // Nested patterns "a", "aa", ... on a long path: every rule is reported once and
+    // the output chains are not rewalked, so the cost stays linear in the path length
+    // Вложенные шаблоны "a", "aa", ... на длинном пути: каждое правило сообщается один раз,
+    // цепочки вывода не проходятся повторно, поэтому время линейно по длине пути
+    enum { NESTED_RULES = 2000, NESTED_PATH = 8000, NESTED_CALLS = 100 };
+    static char run[NESTED_PATH + 16];
+    static struct UriFilterRule nested[NESTED_RULES];
+    static size_t nestedMatches[NESTED_RULES];
+    memset(run, 'a', NESTED_PATH);
+    for (size_t i = 0; i < NESTED_RULES; ++i) {
+        nested[i].kind = URI_FILTER_PATH_CONTAINS;
+        nested[i].pattern = &run[NESTED_PATH - 1 - i]; // Суффикс длины i + 1 / Suffix of length i + 1
+    }
+    filter = uriFilterCreate(nested, NESTED_RULES);
+    scratch = uriFilterScratchCreate(filter);
+    char *nestedUri = malloc(NESTED_PATH + 16);
+    if (filter == nullptr || scratch == nullptr || nestedUri == nullptr) {
+        failed |= check(0, "filter: nested rules created");
+    } else {
+        strcpy(nestedUri, "http://h/");
+        strcat(nestedUri, run);
+        uri = uriCreate(nestedUri);
+        int allFound = uri != nullptr;
+        clock_t start = clock();
+        for (int i = 0; i < NESTED_CALLS && allFound; ++i) {
+            allFound = uriFilterMatch(filter, uri, scratch, nestedMatches, NESTED_RULES) == NESTED_RULES;
+        }
+        double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+        failed |= check(allFound, "filter: nested rules all reported");
+        // Квадратичная версия тратила около секунды на один вызов
+        // The quadratic version spent about a second per call
+        failed |= check(seconds < 1.0, "filter: nested rules matched in linear time");
+        uriDestroy(uri);
+    }
+    free(nestedUri);
+    uriFilterScratchDestroy(scratch);
+    uriFilterDestroy(filter);
+
+    // Empty rule set / Пустой набор правил
+    filter = uriFilterCreate(nullptr, 0);
+    failed |= check(filter != nullptr, "filter: empty rule set created");
+    if (filter) {
+        failed |= expectMatches(filter, "http://example.com/he?k", nullptr, 0);
+        uriFilterDestroy(filter);
+    }
+
+    // Invalid rules / Некорректные правила
+    const struct UriFilterRule dotsOnly[] = {{URI_FILTER_HOST_SUFFIX, "..."}};
+    const struct UriFilterRule nullPattern[] = {{URI_FILTER_PATH_PREFIX, nullptr}};
+    const struct UriFilterRule emptyPattern[] = {{URI_FILTER_PATH_CONTAINS, ""}};
+    const struct UriFilterRule unknownKind[] = {{(enum UriFilterRuleKind)42, "x"}};
+    failed |= check(uriFilterCreate(dotsOnly, 1) == nullptr, "filter: dots-only host rejected");
+    failed |= check(uriFilterCreate(nullPattern, 1) == nullptr, "filter: NULL pattern rejected");
+    failed |= check(uriFilterCreate(emptyPattern, 1) == nullptr, "filter: empty pattern rejected");
+    failed |= check(uriFilterCreate(unknownKind, 1) == nullptr, "filter: unknown kind rejected");
+
+    // Patterns that could never match / Шаблоны, которые никогда не совпали бы
+    const struct UriFilterRule deadRules[] = {
+            {URI_FILTER_QUERY_KEY, "utm_source="},
+            {URI_FILTER_QUERY_KEY, "a&b"},
+            {URI_FILTER_QUERY_KEY, "a#"},
+            {URI_FILTER_HOST_SUFFIX, "example.com:8080"},
+            {URI_FILTER_HOST_SUFFIX, "example.com/a"},
+            {URI_FILTER_HOST_SUFFIX, "example.com?"},
+            {URI_FILTER_HOST_SUFFIX, "example.com#"},
+            {URI_FILTER_HOST_SUFFIX, "[::1]"},
+            {URI_FILTER_PATH_PREFIX, "/a?x=1"},
+            {URI_FILTER_PATH_PREFIX, "/a#top"},
+            {URI_FILTER_PATH_CONTAINS, "a?"},
+            {URI_FILTER_PATH_CONTAINS, "#a"}
+    };
+    for (size_t i = 0; i < sizeof(deadRules) / sizeof(deadRules[0]); ++i) {
+        if (uriFilterCreate(&deadRules[i], 1) != nullptr) {
+            printf("Check failed: filter: dead pattern \"%s\" rejected\n", deadRules[i].pattern);
+            failed = 1;
+        }
+    }
+
+    const struct UriFilterRule queryRule[] = {{URI_FILTER_QUERY_KEY, "utm_source"}};
+    filter = uriFilterCreate(queryRule, 1);
+    failed |= check(filter != nullptr, "filter: query key rule created");
+    if (filter) {
+        failed |= expectMatches(filter, "http://example.com:8080/a?x=1&utm_source=z&a&b", (const size_t[]){0}, 1);
+        uriFilterDestroy(filter);
+    }
+
+    return failed;
+}
+
+/**
+ * @brief Parses a few URIs on another thread and exits.
+ *
+ * @brief Разбирает несколько URI в другом потоке и завершается.
+ */
+static int statsWorker(void *argument) {
+    (void)argument;
+    for (int i = 0; i < 3; ++i) {
+        uriDestroy(uriCreate("http://worker.example/"));
+    }
+    return 0;
+}
 
+/**
+ * @brief Tests the parser statistics. Only meaningful when built with URI_STATS.
+ *
+ * @return int 0 on success, 1 on failure.
+ *
+ * @brief Тестирует статистику парсера. Имеет смысл только при сборке с URI_STATS.
+ *
+ * @return int 0 при успешном выполнении, 1 при ошибке.
+ */
+static int testStats(void) {
+    int failed = 0;
+    const struct UriStats zero = {0};
+    struct UriStats stats;
+
+    // Failures by reason / Ошибки по причинам
+    uriStatsReset();
+    failed |= check(uriCreate(nullptr) == nullptr, "stats: NULL input rejected");
+    failed |= check(uriCreate("noscheme") == nullptr, "stats: missing scheme rejected");
+    failed |= check(uriCreate("http://h:99999") == nullptr, "stats: port out of range rejected");
+    failed |= check(uriCreate("http://[::1") == nullptr, "stats: unterminated host rejected");
+    uriStatsSnapshot(&stats);
+    failed |= check(stats.parses == 4 && stats.successes == 0, "stats: parses counted");
+    failed |= check(stats.failures[URI_STATS_FAILURE_NULL_INPUT] == 1, "stats: null_input");
+    failed |= check(stats.failures[URI_STATS_FAILURE_MISSING_SCHEME] == 1, "stats: missing_scheme");
+    failed |= check(stats.failures[URI_STATS_FAILURE_PORT_RANGE] == 1, "stats: port_range");
+    failed |= check(stats.failures[URI_STATS_FAILURE_UNTERMINATED_HOST] == 1, "stats: unterminated_host");
+    failed |= check(stats.failures[URI_STATS_FAILURE_OUT_OF_MEMORY] == 0, "stats: out_of_memory");
+
+    // JSON dump / Вывод JSON
+    char json[8192] = {0};
+    FILE *stream = tmpfile();
+    failed |= check(stream != nullptr && uriStatsDumpJson(stream, &stats) == 0, "stats: JSON dump written");
+    if (stream) {
+        rewind(stream);
+        size_t length = fread(json, 1, sizeof(json) - 1, stream);
+        json[length] = '\0';
+        fclose(stream);
+    }
+    failed |= check(jsonBalanced(json), "stats: JSON dump well-formed");
+    failed |= check(strstr(json, "\"missing_scheme\":1,") != nullptr, "stats: JSON dump has failure counts");
+
+    // Reset / Сброс
+    uriStatsReset();
+    uriStatsSnapshot(&stats);
+    failed |= check(memcmp(&stats, &zero, sizeof(stats)) == 0, "stats: reset zeroes counters");
+
+    // Allocated bytes and histograms: "http" + "h" + "/p" + buffer "http://h/p"
+    // Выделенные байты и гистограммы: "http" + "h" + "/p" + буфер "http://h/p"
+    struct Uri *uri = uriCreate("http://h/p");
+    uriStatsSnapshot(&stats);
+    failed |= check(uri != nullptr && stats.successes == 1, "stats: success counted");
+    failed |= check(stats.createAllocations == 5, "stats: create allocations");
+    failed |= check(stats.createBytes == sizeof(struct Uri) + 5 + 2 + 3 + 11, "stats: create bytes");
+    failed |= check(stats.componentLengths[URI_STATS_COMPONENT_HOST][1] == 1, "stats: host length histogram");
+    failed |= check(stats.componentLengths[URI_STATS_COMPONENT_PATH][2] == 1, "stats: path length histogram");
+    failed |= check(stats.componentLengths[URI_STATS_COMPONENT_QUERY][0] == 1, "stats: empty query histogram");
+    for (size_t i = 0; i < URI_STATS_STAGE_COUNT; ++i) {
+        failed |= check(stats.stageRuns[i] == 1, "stats: stage runs");
+    }
+    if (uri) {
+        char *fullUri = uriGetFullUri(uri);
+        uriStatsSnapshot(&stats);
+        failed |= check(stats.fullUriAllocations == 1 && stats.fullUriBytes == 11, "stats: full URI bytes");
+        free(fullUri);
+        uriDestroy(uri);
+    }
+
+    // Merge adds every counter / Объединение складывает каждый счетчик
+    unsigned long long counters[sizeof(struct UriStats) / sizeof(unsigned long long)];
+    for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); ++i) {
+        counters[i] = i + 1;
+    }
+    struct UriStats source;
+    memcpy(&source, counters, sizeof(source));
+    struct UriStats destination = source;
+    uriStatsMerge(&destination, &source);
+    memcpy(counters, &destination, sizeof(counters));
+    int merged = 1;
+    for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); ++i) {
+        merged &= counters[i] == 2 * (i + 1);
+    }
+    failed |= check(merged, "stats: merge adds every counter");
+
+    // Counters of an exited thread stay visible / Счетчики завершившегося потока остаются видимыми
+    struct UriStats before;
+    uriStatsSnapshotAll(&before);
+    thrd_t worker;
+    failed |= check(thrd_create(&worker, statsWorker, nullptr) == thrd_success, "stats: worker started");
+    thrd_join(worker, nullptr);
+    uriStatsSnapshotAll(&stats);
+    failed |= check(stats.parses == before.parses + 3 && stats.successes == before.successes + 3, "stats: exited thread counted");
+
+    return failed;
+}
 
 int main() {
     int result = 0;
@@ -55,5 +424,45 @@ int main() {
 
     }
 
+    const struct UriFilterRule rules[] = {
+            {URI_FILTER_HOST_SUFFIX, "example1.com"},
+            {URI_FILTER_HOST_SUFFIX, "yandex.kz"},
+            {URI_FILTER_PATH_PREFIX, "/path/to/"},
+            {URI_FILTER_PATH_CONTAINS, "rtx-4070"},
+            {URI_FILTER_QUERY_KEY, "sponsored"}
+    };
+    struct UriFilter *filter = uriFilterCreate(rules, sizeof(rules) / sizeof(rules[0]));
+    if (filter == NULL) {
+        printf("Failed to create filter\n");
+        result = 1;
+    } else {
+        struct UriFilterScratch *scratch = uriFilterScratchCreate(filter);
+        size_t total = 0;
+        for (size_t i = 0; i < sizeof(uriArray) / sizeof(uriArray[0]); ++i) {
+            struct Uri *uri = uriCreate(uriArray[i]);
+            if (uri == NULL) {
+                continue;
+            }
+            size_t matches[5];
+            size_t count = uriFilterMatch(filter, uri, scratch, matches, 5);
+            total += count;
+            for (size_t j = 0; j < count; ++j) {
+                printf("Filter match: %s -> rule %zu (%s)\n", uriArray[i], matches[j], rules[matches[j]].pattern);
+            }
+            uriDestroy(uri);
+        }
+        uriFilterScratchDestroy(scratch);
+        uriFilterDestroy(filter);
+        result |= check(total == 8, "filter: matches over uriArray");
+    }
+
+    if (testFilter() != 0) {
+        result = 1;
+    }
+
+    if (uriStatsEnabled() && testStats() != 0) {
+        result = 1;
+    }
+
     return result;
 }
\ No newline at end of file
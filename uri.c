@@ -1,4 +1,5 @@
 #include "uri.h"
+#include "uri_stats.h"
 
 #include <errno.h>
 #include <stdio.h>
@@ -22,6 +23,8 @@
 static char *strndupSafe(const char *source, size_t length) {
     char *destination = malloc(length + 1);
     if (destination) {
+        URI_STATS_ADD(createAllocations, 1);
+        URI_STATS_ADD(createBytes, length + 1);
         memcpy(destination, source, length);
         destination[length] = '\0';
     }
@@ -45,11 +48,13 @@ static char *strndupSafe(const char *source, size_t length) {
 static int parseScheme(const char **uriString, char **scheme, size_t *schemeLength) {
     const char *pos = strstr(*uriString, ":");
     if (pos == nullptr) {
+        URI_STATS_FAIL(URI_STATS_FAILURE_MISSING_SCHEME);
         return -1;
     }
     *schemeLength = pos - *uriString;
     *scheme = strndupSafe(*uriString, *schemeLength);
     if (*scheme == nullptr) { // Проверка успешности выделения памяти
+        URI_STATS_FAIL(URI_STATS_FAILURE_OUT_OF_MEMORY);
         return -1;
     }
     *uriString = pos + 1;
@@ -94,6 +99,7 @@ static int parseAuthority(const char **uriString, char **userInfo, size_t *userI
         *userInfoLength = atPos - pos;
         *userInfo = strndupSafe(pos, *userInfoLength);
         if (*userInfo == nullptr) { // Проверка успешности выделения памяти
+            URI_STATS_FAIL(URI_STATS_FAILURE_OUT_OF_MEMORY);
             return -1;
         }
         pos = atPos + 1;
@@ -103,11 +109,13 @@ static int parseAuthority(const char **uriString, char **userInfo, size_t *userI
     *hostLength = hostEnd - pos;
     *host = strndupSafe(pos, *hostLength);
     if (*host == nullptr) { // Проверка успешности выделения памяти
+        URI_STATS_FAIL(URI_STATS_FAILURE_OUT_OF_MEMORY);
         return -1;
     }
     pos = hostEnd;
 
     if ((*host)[0] == '[' && (*host)[*hostLength - 1] != ']') {
+        URI_STATS_FAIL(URI_STATS_FAILURE_UNTERMINATED_HOST);
         return -1;
     }
 
@@ -120,10 +128,12 @@ static int parseAuthority(const char **uriString, char **userInfo, size_t *userI
         *portLength = pos - portStart;
         *port = strndupSafe(portStart, *portLength);
         if (*port == nullptr) { // Проверка успешности выделения памяти
+            URI_STATS_FAIL(URI_STATS_FAILURE_OUT_OF_MEMORY);
             return -1;
         }
         unsigned long portNum = strtoul(*port, nullptr, 10);
         if (portNum > MAX_PORT_NUMBER) {
+            URI_STATS_FAIL(URI_STATS_FAILURE_PORT_RANGE);
             return -1;
         }
     }
@@ -204,7 +214,9 @@ static void parsePathQueryFragment(const char *uriString, char **path, size_t *p
  * @return struct Uri* Указатель на созданную структуру Uri, или nullptr в случае ошибки.
  */
 struct Uri *uriCreate(const char *uriString) {
+    URI_STATS_ADD(parses, 1);
     if (uriString == nullptr) {
+        URI_STATS_FAIL(URI_STATS_FAILURE_NULL_INPUT);
         return nullptr;
     }
 
@@ -212,11 +224,17 @@ struct Uri *uriCreate(const char *uriString) {
     struct Uri *uri = calloc(1, sizeof(*uri));
     if (uri == nullptr) {
 //        printf("Memory allocation failed for Uri structure.\n");
+        URI_STATS_FAIL(URI_STATS_FAILURE_OUT_OF_MEMORY);
         return nullptr;
     }
+    URI_STATS_ADD(createAllocations, 1);
+    URI_STATS_ADD(createBytes, sizeof(*uri));
 
     const char *pos = uriString;
-    if (parseScheme(&pos, &uri->scheme, &uri->schemeLength) < 0) {
+    URI_STATS_STAGE_BEGIN(scheme);
+    int schemeResult = parseScheme(&pos, &uri->scheme, &uri->schemeLength);
+    URI_STATS_STAGE_END(scheme, URI_STATS_STAGE_SCHEME);
+    if (schemeResult < 0) {
 //        printf("Failed to parse scheme.\n");
         uriDestroy(uri);
         return nullptr;
@@ -224,7 +242,10 @@ struct Uri *uriCreate(const char *uriString) {
 
 //    printf("Scheme parsed successfully: %.*s\n", (int)uri->schemeLength, uri->scheme);
 
-    if (parseAuthority(&pos, &uri->userInfo, &uri->userInfoLength, &uri->host, &uri->hostLength, &uri->port, &uri->portLength) < 0) {
+    URI_STATS_STAGE_BEGIN(authority);
+    int authorityResult = parseAuthority(&pos, &uri->userInfo, &uri->userInfoLength, &uri->host, &uri->hostLength, &uri->port, &uri->portLength);
+    URI_STATS_STAGE_END(authority, URI_STATS_STAGE_AUTHORITY);
+    if (authorityResult < 0) {
 //        printf("Failed to parse authority.\n");
         uriDestroy(uri);
         return nullptr;
@@ -235,7 +256,9 @@ struct Uri *uriCreate(const char *uriString) {
 //    printf("Host: %.*s\n", (int)uri->hostLength, uri->host);
 //    printf("Port: %.*s\n", (int)uri->portLength, uri->port);
 
+    URI_STATS_STAGE_BEGIN(pathQueryFragment);
     parsePathQueryFragment(pos, &uri->path, &uri->pathLength, &uri->query, &uri->queryLength, &uri->fragment, &uri->fragmentLength);
+    URI_STATS_STAGE_END(pathQueryFragment, URI_STATS_STAGE_PATH_QUERY_FRAGMENT);
 
 //    printf("Path, query, and fragment parsed successfully.\n");
 //    printf("Path: %.*s\n", (int)uri->pathLength, uri->path);
@@ -243,6 +266,8 @@ struct Uri *uriCreate(const char *uriString) {
 //    printf("Fragment: %.*s\n", (int)uri->fragmentLength, uri->fragment);
 //    printf("Scheme: %.*s\n", (int)uri->schemeLength, uri->scheme);
 
+    URI_STATS_STAGE_BEGIN(buffer);
+
     // Calculate the total length required for the full URI string
     size_t totalLength = uri->schemeLength + 3 + // scheme + "://"
                          uri->userInfoLength + (uri->userInfoLength ? 1 : 0) + // userInfo + "@"
@@ -257,9 +282,13 @@ struct Uri *uriCreate(const char *uriString) {
     uri->buffer = malloc(totalLength);
     if (uri->buffer == nullptr) {
 //        printf("Memory allocation failed for buffer.\n");
+        URI_STATS_STAGE_END(buffer, URI_STATS_STAGE_BUFFER);
+        URI_STATS_FAIL(URI_STATS_FAILURE_OUT_OF_MEMORY);
         uriDestroy(uri);
         return nullptr;
     }
+    URI_STATS_ADD(createAllocations, 1);
+    URI_STATS_ADD(createBytes, totalLength);
 
 //    printf("Constructing full URI...\n");
     char *bufPos = uri->buffer;
@@ -315,6 +344,16 @@ struct Uri *uriCreate(const char *uriString) {
 
 //    printf("Full URI constructed: %s\n", uri->buffer);
 
+    URI_STATS_STAGE_END(buffer, URI_STATS_STAGE_BUFFER);
+    URI_STATS_LENGTH(URI_STATS_COMPONENT_SCHEME, uri->schemeLength);
+    URI_STATS_LENGTH(URI_STATS_COMPONENT_USER_INFO, uri->userInfoLength);
+    URI_STATS_LENGTH(URI_STATS_COMPONENT_HOST, uri->hostLength);
+    URI_STATS_LENGTH(URI_STATS_COMPONENT_PORT, uri->portLength);
+    URI_STATS_LENGTH(URI_STATS_COMPONENT_PATH, uri->pathLength);
+    URI_STATS_LENGTH(URI_STATS_COMPONENT_QUERY, uri->queryLength);
+    URI_STATS_LENGTH(URI_STATS_COMPONENT_FRAGMENT, uri->fragmentLength);
+    URI_STATS_ADD(successes, 1);
+
     return uri;
 }
 
@@ -468,6 +507,8 @@ char *uriGetFullUri(const struct Uri *uri) {
 //        printf("Memory allocation failed for fullUri.\n");
         return nullptr;
     }
+    URI_STATS_ADD(fullUriAllocations, 1);
+    URI_STATS_ADD(fullUriBytes, strlen(fullUri) + 1);
 
     return fullUri;
 }
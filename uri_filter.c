@@ -0,0 +1,884 @@
+#include "uri_filter.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_NODE UINT32_MAX
+#define ROOT_NODE 0
+
+/**
+ * @struct TrieBuildNode
+ * @brief Trie node while rules are being inserted. Edges are kept sorted by label.
+ *
+ * @struct TrieBuildNode
+ * @brief Узел дерева во время добавления правил. Ребра хранятся отсортированными по метке.
+ */
+struct TrieBuildNode {
+    unsigned char *labels; /**< Edge labels / Метки ребер */
+    uint32_t *children;    /**< Edge targets / Цели ребер */
+    uint32_t edgeCount;    /**< Number of edges / Количество ребер */
+};
+
+/**
+ * @struct TrieRuleRef
+ * @brief Rule attached to a trie node.
+ *
+ * @struct TrieRuleRef
+ * @brief Правило, привязанное к узлу дерева.
+ */
+struct TrieRuleRef {
+    uint32_t node; /**< Node index / Индекс узла */
+    size_t rule;   /**< Rule identifier / Идентификатор правила */
+};
+
+/**
+ * @struct TrieBuilder
+ * @brief Mutable trie used only inside uriFilterCreate.
+ *
+ * @struct TrieBuilder
+ * @brief Изменяемое дерево, используемое только внутри uriFilterCreate.
+ */
+struct TrieBuilder {
+    struct TrieBuildNode *nodes; /**< Nodes / Узлы */
+    uint32_t nodeCount;          /**< Number of nodes / Количество узлов */
+    uint32_t nodeCapacity;       /**< Capacity of nodes / Емкость массива узлов */
+    struct TrieRuleRef *refs;    /**< Rules attached to nodes / Правила, привязанные к узлам */
+    size_t refCount;             /**< Number of refs / Количество привязок */
+    size_t refCapacity;          /**< Capacity of refs / Емкость массива привязок */
+};
+
+/**
+ * @struct FilterTrie
+ * @brief Frozen trie in flat arrays. Edges of node n are
+ * edgeLabels/edgeTargets[edgeStart[n] .. edgeStart[n + 1]), sorted by label;
+ * its rules are rules[ruleStart[n] .. ruleStart[n + 1]).
+ *
+ * @struct FilterTrie
+ * @brief Замороженное дерево в плоских массивах. Ребра узла n —
+ * edgeLabels/edgeTargets[edgeStart[n] .. edgeStart[n + 1]), отсортированные по метке;
+ * его правила — rules[ruleStart[n] .. ruleStart[n + 1]).
+ */
+struct FilterTrie {
+    uint32_t nodeCount;        /**< Number of nodes / Количество узлов */
+    uint32_t *edgeStart;       /**< First edge of each node / Первое ребро каждого узла */
+    unsigned char *edgeLabels; /**< Edge labels / Метки ребер */
+    uint32_t *edgeTargets;     /**< Edge targets / Цели ребер */
+    uint32_t *ruleStart;       /**< First rule of each node / Первое правило каждого узла */
+    size_t *rules;             /**< Rule identifiers / Идентификаторы правил */
+    uint32_t *fail;            /**< Aho-Corasick failure links, or nullptr / Ссылки неудач Ахо-Корасик, или nullptr */
+    uint32_t *output;          /**< Nearest failure ancestor with rules / Ближайший предок по ссылкам неудач с правилами */
+};
+
+/**
+ * @struct UriFilter
+ * @brief Compiled filter: one automaton per rule kind.
+ *
+ * @struct UriFilter
+ * @brief Скомпилированный фильтр: по одному автомату на каждый вид правил.
+ */
+struct UriFilter {
+    struct FilterTrie hostSuffix;   /**< Reversed host suffixes / Перевернутые суффиксы хоста */
+    struct FilterTrie pathPrefix;   /**< Path prefixes / Префиксы пути */
+    struct FilterTrie pathContains; /**< Path substrings / Подстроки пути */
+    struct FilterTrie queryKey;     /**< Query keys / Ключи запроса */
+    size_t ruleCount;               /**< Number of rules / Количество правил */
+};
+
+/**
+ * @struct UriFilterScratch
+ * @brief Per-thread match state. stamps[rule] == generation means the rule
+ * was already reported by the current uriFilterMatch call.
+ *
+ * @struct UriFilterScratch
+ * @brief Состояние поиска одного потока. stamps[rule] == generation означает,
+ * что правило уже сообщено текущим вызовом uriFilterMatch.
+ */
+struct UriFilterScratch {
+    size_t ruleCount;   /**< Number of stamps / Количество отметок */
+    uint32_t generation;/**< Current call / Текущий вызов */
+    uint32_t stamps[];  /**< Generation per rule / Поколение для каждого правила */
+};
+
+/**
+ * @struct MatchSink
+ * @brief Output buffer for uriFilterMatch that drops duplicate rules.
+ *
+ * @struct MatchSink
+ * @brief Буфер вывода для uriFilterMatch, отбрасывающий повторяющиеся правила.
+ */
+struct MatchSink {
+    size_t *matches;     /**< Output array / Выходной массив */
+    size_t maxMatches;   /**< Capacity / Емкость */
+    size_t count;        /**< Stored identifiers / Сохраненные идентификаторы */
+    uint32_t *stamps;    /**< Scratch stamps / Отметки рабочей области */
+    uint32_t generation; /**< Stamp of this call / Отметка этого вызова */
+};
+
+/**
+ * @brief Lowercases an ASCII character independently of the locale.
+ *
+ * @param c Character.
+ * @return unsigned char Lowercased character.
+ *
+ * @brief Переводит ASCII-символ в нижний регистр независимо от локали.
+ *
+ * @param c Символ.
+ * @return unsigned char Символ в нижнем регистре.
+ */
+static unsigned char asciiLower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c - 'A' + 'a') : c;
+}
+
+/**
+ * @brief Appends an empty node to the builder.
+ *
+ * @param builder Pointer to the builder.
+ * @return uint32_t Index of the new node, or NO_NODE if failed.
+ *
+ * @brief Добавляет пустой узел в построитель.
+ *
+ * @param builder Указатель на построитель.
+ * @return uint32_t Индекс нового узла, или NO_NODE в случае ошибки.
+ */
+static uint32_t builderAddNode(struct TrieBuilder *builder) {
+    if (builder->nodeCount == builder->nodeCapacity) {
+        if (builder->nodeCapacity >= NO_NODE / 2) {
+            return NO_NODE;
+        }
+        uint32_t capacity = builder->nodeCapacity ? builder->nodeCapacity * 2 : 64;
+        struct TrieBuildNode *nodes = realloc(builder->nodes, capacity * sizeof(*nodes));
+        if (nodes == nullptr) {
+            return NO_NODE;
+        }
+        builder->nodes = nodes;
+        builder->nodeCapacity = capacity;
+    }
+    struct TrieBuildNode *node = &builder->nodes[builder->nodeCount];
+    node->labels = nullptr;
+    node->children = nullptr;
+    node->edgeCount = 0;
+    return builder->nodeCount++;
+}
+
+/**
+ * @brief Finds the child of a build node for a label.
+ *
+ * @param node Pointer to the build node.
+ * @param label Edge label.
+ * @param index Pointer to store the edge index, or the insertion point if not found.
+ * @return int 1 if found, 0 otherwise.
+ *
+ * @brief Находит потомка узла построителя по метке.
+ *
+ * @param node Указатель на узел построителя.
+ * @param label Метка ребра.
+ * @param index Указатель для хранения индекса ребра, или места вставки, если не найдено.
+ * @return int 1 если найдено, иначе 0.
+ */
+static int builderFindEdge(const struct TrieBuildNode *node, unsigned char label, uint32_t *index) {
+    uint32_t low = 0;
+    uint32_t high = node->edgeCount;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (node->labels[middle] < label) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    *index = low;
+    return low < node->edgeCount && node->labels[low] == label;
+}
+
+/**
+ * @brief Inserts a pattern into the builder and attaches a rule to its last node.
+ *
+ * @param builder Pointer to the builder.
+ * @param pattern Pattern bytes.
+ * @param length Length of the pattern.
+ * @param reverse Insert the pattern from its last byte to its first.
+ * @param foldCase Lowercase ASCII letters.
+ * @param rule Rule identifier.
+ * @return int 0 on success, -1 on failure.
+ *
+ * @brief Добавляет шаблон в построитель и привязывает правило к его последнему узлу.
+ *
+ * @param builder Указатель на построитель.
+ * @param pattern Байты шаблона.
+ * @param length Длина шаблона.
+ * @param reverse Добавлять шаблон от последнего байта к первому.
+ * @param foldCase Переводить ASCII-буквы в нижний регистр.
+ * @param rule Идентификатор правила.
+ * @return int 0 при успешном выполнении, -1 при ошибке.
+ */
+static int builderInsert(struct TrieBuilder *builder, const char *pattern, size_t length, int reverse, int foldCase, size_t rule) {
+    uint32_t current = ROOT_NODE;
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char label = (unsigned char)pattern[reverse ? length - 1 - i : i];
+        if (foldCase) {
+            label = asciiLower(label);
+        }
+
+        uint32_t index;
+        if (builderFindEdge(&builder->nodes[current], label, &index)) {
+            current = builder->nodes[current].children[index];
+            continue;
+        }
+
+        uint32_t child = builderAddNode(builder);
+        if (child == NO_NODE) {
+            return -1;
+        }
+        struct TrieBuildNode *node = &builder->nodes[current];
+        unsigned char *labels = realloc(node->labels, node->edgeCount + 1);
+        if (labels == nullptr) {
+            return -1;
+        }
+        node->labels = labels;
+        uint32_t *children = realloc(node->children, (node->edgeCount + 1) * sizeof(*children));
+        if (children == nullptr) {
+            return -1;
+        }
+        node->children = children;
+        memmove(&labels[index + 1], &labels[index], node->edgeCount - index);
+        memmove(&children[index + 1], &children[index], (node->edgeCount - index) * sizeof(*children));
+        labels[index] = label;
+        children[index] = child;
+        node->edgeCount++;
+        current = child;
+    }
+
+    if (builder->refCount == builder->refCapacity) {
+        size_t capacity = builder->refCapacity ? builder->refCapacity * 2 : 16;
+        struct TrieRuleRef *refs = realloc(builder->refs, capacity * sizeof(*refs));
+        if (refs == nullptr) {
+            return -1;
+        }
+        builder->refs = refs;
+        builder->refCapacity = capacity;
+    }
+    builder->refs[builder->refCount].node = current;
+    builder->refs[builder->refCount].rule = rule;
+    builder->refCount++;
+    return 0;
+}
+
+/**
+ * @brief Frees the memory owned by the builder.
+ *
+ * @param builder Pointer to the builder.
+ *
+ * @brief Освобождает память, принадлежащую построителю.
+ *
+ * @param builder Указатель на построитель.
+ */
+static void builderFree(struct TrieBuilder *builder) {
+    for (uint32_t i = 0; i < builder->nodeCount; ++i) {
+        free(builder->nodes[i].labels);
+        free(builder->nodes[i].children);
+    }
+    free(builder->nodes);
+    free(builder->refs);
+}
+
+/**
+ * @brief Frees the arrays of a frozen trie.
+ *
+ * @param trie Pointer to the trie.
+ *
+ * @brief Освобождает массивы замороженного дерева.
+ *
+ * @param trie Указатель на дерево.
+ */
+static void trieFree(struct FilterTrie *trie) {
+    free(trie->edgeStart);
+    free(trie->edgeLabels);
+    free(trie->edgeTargets);
+    free(trie->ruleStart);
+    free(trie->rules);
+    free(trie->fail);
+    free(trie->output);
+}
+
+/**
+ * @brief Follows the edge of a frozen trie node for a label.
+ *
+ * @param trie Pointer to the trie.
+ * @param node Node index.
+ * @param label Edge label.
+ * @return uint32_t Target node, or NO_NODE if there is no such edge.
+ *
+ * @brief Переходит по ребру узла замороженного дерева с заданной меткой.
+ *
+ * @param trie Указатель на дерево.
+ * @param node Индекс узла.
+ * @param label Метка ребра.
+ * @return uint32_t Целевой узел, или NO_NODE, если такого ребра нет.
+ */
+static uint32_t trieStep(const struct FilterTrie *trie, uint32_t node, unsigned char label) {
+    uint32_t low = trie->edgeStart[node];
+    uint32_t high = trie->edgeStart[node + 1];
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (trie->edgeLabels[middle] < label) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low < trie->edgeStart[node + 1] && trie->edgeLabels[low] == label) {
+        return trie->edgeTargets[low];
+    }
+    return NO_NODE;
+}
+
+/**
+ * @brief Computes Aho-Corasick failure and output links in breadth-first order.
+ *
+ * @param trie Pointer to the trie.
+ * @return int 0 on success, -1 on failure.
+ *
+ * @brief Вычисляет ссылки неудач и вывода Ахо-Корасик в порядке обхода в ширину.
+ *
+ * @param trie Указатель на дерево.
+ * @return int 0 при успешном выполнении, -1 при ошибке.
+ */
+static int trieLinkFailures(struct FilterTrie *trie) {
+    trie->fail = malloc(trie->nodeCount * sizeof(*trie->fail));
+    trie->output = malloc(trie->nodeCount * sizeof(*trie->output));
+    uint32_t *queue = malloc(trie->nodeCount * sizeof(*queue));
+    if (trie->fail == nullptr || trie->output == nullptr || queue == nullptr) {
+        free(queue);
+        return -1;
+    }
+
+    size_t head = 0;
+    size_t tail = 0;
+    trie->fail[ROOT_NODE] = ROOT_NODE;
+    trie->output[ROOT_NODE] = NO_NODE;
+    queue[tail++] = ROOT_NODE;
+
+    while (head < tail) {
+        uint32_t node = queue[head++];
+        for (uint32_t edge = trie->edgeStart[node]; edge < trie->edgeStart[node + 1]; ++edge) {
+            unsigned char label = trie->edgeLabels[edge];
+            uint32_t child = trie->edgeTargets[edge];
+
+            uint32_t fallback = ROOT_NODE;
+            if (node != ROOT_NODE) {
+                uint32_t candidate = trie->fail[node];
+                while (trieStep(trie, candidate, label) == NO_NODE && candidate != ROOT_NODE) {
+                    candidate = trie->fail[candidate];
+                }
+                uint32_t next = trieStep(trie, candidate, label);
+                if (next != NO_NODE) {
+                    fallback = next;
+                }
+            }
+            trie->fail[child] = fallback;
+            trie->output[child] = trie->ruleStart[fallback] != trie->ruleStart[fallback + 1] ? fallback : trie->output[fallback];
+            queue[tail++] = child;
+        }
+    }
+
+    free(queue);
+    return 0;
+}
+
+/**
+ * @brief Converts a builder into a frozen trie.
+ *
+ * @param builder Pointer to the builder.
+ * @param trie Pointer to store the trie.
+ * @param withFailureLinks Also compute Aho-Corasick links.
+ * @return int 0 on success, -1 on failure.
+ *
+ * @brief Преобразует построитель в замороженное дерево.
+ *
+ * @param builder Указатель на построитель.
+ * @param trie Указатель для хранения дерева.
+ * @param withFailureLinks Также вычислить ссылки Ахо-Корасик.
+ * @return int 0 при успешном выполнении, -1 при ошибке.
+ */
+static int trieFreeze(const struct TrieBuilder *builder, struct FilterTrie *trie, int withFailureLinks) {
+    uint32_t nodeCount = builder->nodeCount;
+    size_t edgeCount = nodeCount - 1; // Каждый узел, кроме корня, имеет ровно одно входящее ребро
+
+    trie->nodeCount = nodeCount;
+    trie->edgeStart = malloc((nodeCount + 1) * sizeof(*trie->edgeStart));
+    trie->edgeLabels = malloc(edgeCount ? edgeCount : 1);
+    trie->edgeTargets = malloc((edgeCount ? edgeCount : 1) * sizeof(*trie->edgeTargets));
+    trie->ruleStart = calloc(nodeCount + 1, sizeof(*trie->ruleStart));
+    trie->rules = malloc((builder->refCount ? builder->refCount : 1) * sizeof(*trie->rules));
+    if (trie->edgeStart == nullptr || trie->edgeLabels == nullptr || trie->edgeTargets == nullptr ||
+        trie->ruleStart == nullptr || trie->rules == nullptr) {
+        return -1;
+    }
+
+    uint32_t edge = 0;
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        const struct TrieBuildNode *node = &builder->nodes[i];
+        trie->edgeStart[i] = edge;
+        if (node->edgeCount) {
+            memcpy(&trie->edgeLabels[edge], node->labels, node->edgeCount);
+            memcpy(&trie->edgeTargets[edge], node->children, node->edgeCount * sizeof(*trie->edgeTargets));
+            edge += node->edgeCount;
+        }
+    }
+    trie->edgeStart[nodeCount] = edge;
+
+    // Counting sort of rule references by node
+    // Сортировка подсчетом привязок правил по узлам
+    for (size_t i = 0; i < builder->refCount; ++i) {
+        trie->ruleStart[builder->refs[i].node + 1]++;
+    }
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        trie->ruleStart[i + 1] += trie->ruleStart[i];
+    }
+    uint32_t *fill = malloc(nodeCount * sizeof(*fill));
+    if (fill == nullptr) {
+        return -1;
+    }
+    memcpy(fill, trie->ruleStart, nodeCount * sizeof(*fill));
+    for (size_t i = 0; i < builder->refCount; ++i) {
+        trie->rules[fill[builder->refs[i].node]++] = builder->refs[i].rule;
+    }
+    free(fill);
+
+    if (withFailureLinks) {
+        return trieLinkFailures(trie);
+    }
+    return 0;
+}
+
+/**
+ * @brief Stores a rule identifier unless it is already stored.
+ *
+ * @param sink Pointer to the sink.
+ * @param rule Rule identifier.
+ * @return int 1 if the sink is full, 0 otherwise.
+ *
+ * @brief Сохраняет идентификатор правила, если он еще не сохранен.
+ *
+ * @param sink Указатель на приемник.
+ * @param rule Идентификатор правила.
+ * @return int 1 если приемник заполнен, иначе 0.
+ */
+static int sinkAdd(struct MatchSink *sink, size_t rule) {
+    if (sink->stamps[rule] == sink->generation) {
+        return 0;
+    }
+    sink->stamps[rule] = sink->generation;
+    sink->matches[sink->count++] = rule;
+    return sink->count == sink->maxMatches;
+}
+
+/**
+ * @brief Tells whether the rules of a trie node were already stored by this call.
+ *
+ * @param trie Pointer to the trie.
+ * @param node Node index.
+ * @param sink Pointer to the sink.
+ * @return int 1 if the node has rules and they were stored, 0 otherwise.
+ *
+ * @brief Сообщает, были ли правила узла дерева уже сохранены этим вызовом.
+ *
+ * @param trie Указатель на дерево.
+ * @param node Индекс узла.
+ * @param sink Указатель на приемник.
+ * @return int 1 если у узла есть правила и они сохранены, иначе 0.
+ */
+static int sinkHasNode(const struct FilterTrie *trie, uint32_t node, const struct MatchSink *sink) {
+    uint32_t first = trie->ruleStart[node];
+    return first != trie->ruleStart[node + 1] && sink->stamps[trie->rules[first]] == sink->generation;
+}
+
+/**
+ * @brief Stores all rules attached to a trie node.
+ *
+ * @param trie Pointer to the trie.
+ * @param node Node index.
+ * @param sink Pointer to the sink.
+ * @return int 1 if the sink is full, 0 otherwise.
+ *
+ * @brief Сохраняет все правила, привязанные к узлу дерева.
+ *
+ * @param trie Указатель на дерево.
+ * @param node Индекс узла.
+ * @param sink Указатель на приемник.
+ * @return int 1 если приемник заполнен, иначе 0.
+ */
+static int sinkAddNode(const struct FilterTrie *trie, uint32_t node, struct MatchSink *sink) {
+    for (uint32_t i = trie->ruleStart[node]; i < trie->ruleStart[node + 1]; ++i) {
+        if (sinkAdd(sink, trie->rules[i])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Matches host suffix rules by walking the reversed host.
+ *
+ * @param trie Pointer to the host suffix trie.
+ * @param host Host string.
+ * @param hostLength Length of the host.
+ * @param sink Pointer to the sink.
+ * @return int 1 if the sink is full, 0 otherwise.
+ *
+ * @brief Проверяет правила суффиксов хоста, проходя хост в обратном порядке.
+ *
+ * @param trie Указатель на дерево суффиксов хоста.
+ * @param host Строка хоста.
+ * @param hostLength Длина хоста.
+ * @param sink Указатель на приемник.
+ * @return int 1 если приемник заполнен, иначе 0.
+ */
+static int matchHostSuffix(const struct FilterTrie *trie, const char *host, size_t hostLength, struct MatchSink *sink) {
+    // Полное доменное имя "example.com." обозначает тот же хост, что и "example.com"
+    // The fully qualified "example.com." names the same host as "example.com"
+    if (hostLength > 0 && host[hostLength - 1] == '.') {
+        hostLength--;
+    }
+
+    uint32_t node = ROOT_NODE;
+    for (size_t i = hostLength; i > 0; --i) {
+        node = trieStep(trie, node, asciiLower((unsigned char)host[i - 1]));
+        if (node == NO_NODE) {
+            return 0;
+        }
+        // Совпадение только на границе метки: "example.com" не совпадает с "badexample.com"
+        // Match only on a label boundary: "example.com" does not match "badexample.com"
+        if ((i == 1 || host[i - 2] == '.') && sinkAddNode(trie, node, sink)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Matches path prefix rules.
+ *
+ * @param trie Pointer to the path prefix trie.
+ * @param path Path string.
+ * @param pathLength Length of the path.
+ * @param sink Pointer to the sink.
+ * @return int 1 if the sink is full, 0 otherwise.
+ *
+ * @brief Проверяет правила префиксов пути.
+ *
+ * @param trie Указатель на дерево префиксов пути.
+ * @param path Строка пути.
+ * @param pathLength Длина пути.
+ * @param sink Указатель на приемник.
+ * @return int 1 если приемник заполнен, иначе 0.
+ */
+static int matchPathPrefix(const struct FilterTrie *trie, const char *path, size_t pathLength, struct MatchSink *sink) {
+    uint32_t node = ROOT_NODE;
+    for (size_t i = 0; i < pathLength; ++i) {
+        node = trieStep(trie, node, (unsigned char)path[i]);
+        if (node == NO_NODE) {
+            return 0;
+        }
+        if (sinkAddNode(trie, node, sink)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Matches path substring rules with the Aho-Corasick automaton.
+ *
+ * @param trie Pointer to the path substring trie.
+ * @param path Path string.
+ * @param pathLength Length of the path.
+ * @param sink Pointer to the sink.
+ * @return int 1 if the sink is full, 0 otherwise.
+ *
+ * @brief Проверяет правила подстрок пути с помощью автомата Ахо-Корасик.
+ *
+ * @param trie Указатель на дерево подстрок пути.
+ * @param path Строка пути.
+ * @param pathLength Длина пути.
+ * @param sink Указатель на приемник.
+ * @return int 1 если приемник заполнен, иначе 0.
+ */
+static int matchPathContains(const struct FilterTrie *trie, const char *path, size_t pathLength, struct MatchSink *sink) {
+    uint32_t node = ROOT_NODE;
+    for (size_t i = 0; i < pathLength; ++i) {
+        unsigned char label = (unsigned char)path[i];
+        uint32_t next = trieStep(trie, node, label);
+        while (next == NO_NODE && node != ROOT_NODE) {
+            node = trie->fail[node];
+            next = trieStep(trie, node, label);
+        }
+        node = next == NO_NODE ? ROOT_NODE : next;
+
+        // Узел, уже сообщенный ранее, сообщил и всю свою цепочку вывода
+        // A node reported earlier has already reported its whole output chain
+        for (uint32_t hit = node; hit != NO_NODE && !sinkHasNode(trie, hit, sink); hit = trie->output[hit]) {
+            if (sinkAddNode(trie, hit, sink)) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Matches query key rules against every "key" or "key=value" parameter.
+ *
+ * @param trie Pointer to the query key trie.
+ * @param query Query string.
+ * @param queryLength Length of the query.
+ * @param sink Pointer to the sink.
+ * @return int 1 if the sink is full, 0 otherwise.
+ *
+ * @brief Проверяет правила ключей запроса для каждого параметра "key" или "key=value".
+ *
+ * @param trie Указатель на дерево ключей запроса.
+ * @param query Строка запроса.
+ * @param queryLength Длина запроса.
+ * @param sink Указатель на приемник.
+ * @return int 1 если приемник заполнен, иначе 0.
+ */
+static int matchQueryKey(const struct FilterTrie *trie, const char *query, size_t queryLength, struct MatchSink *sink) {
+    size_t i = 0;
+    while (i < queryLength) {
+        uint32_t node = ROOT_NODE;
+        while (i < queryLength && query[i] != '=' && query[i] != '&') {
+            if (node != NO_NODE) {
+                node = trieStep(trie, node, (unsigned char)query[i]);
+            }
+            i++;
+        }
+        if (node != NO_NODE && node != ROOT_NODE && sinkAddNode(trie, node, sink)) {
+            return 1;
+        }
+        while (i < queryLength && query[i] != '&') {
+            i++;
+        }
+        i++;
+    }
+    return 0;
+}
+
+/**
+ * @brief Compiles the given rules into a filter.
+ *
+ * @param rules Array of rules.
+ * @param ruleCount Number of rules.
+ * @return struct UriFilter* Pointer to the created filter, or nullptr if a rule is invalid (unknown kind, empty pattern, or a pattern that could never match) or allocation failed.
+ *
+ * @brief Компилирует заданные правила в фильтр.
+ *
+ * @param rules Массив правил.
+ * @param ruleCount Количество правил.
+ * @return struct UriFilter* Указатель на созданный фильтр, или nullptr, если правило некорректно (неизвестный вид, пустой шаблон или шаблон, который никогда не совпал бы) или не удалось выделить память.
+ */
+struct UriFilter *uriFilterCreate(const struct UriFilterRule *rules, size_t ruleCount) {
+    if (rules == nullptr && ruleCount != 0) {
+        return nullptr;
+    }
+
+    struct UriFilter *filter = calloc(1, sizeof(*filter));
+    if (filter == nullptr) {
+        return nullptr;
+    }
+    filter->ruleCount = ruleCount;
+
+    struct TrieBuilder builders[4] = {0};
+    struct TrieBuilder *hostSuffix = &builders[0];
+    struct TrieBuilder *pathPrefix = &builders[1];
+    struct TrieBuilder *pathContains = &builders[2];
+    struct TrieBuilder *queryKey = &builders[3];
+    int result = 0;
+
+    for (size_t i = 0; i < 4 && result == 0; ++i) {
+        if (builderAddNode(&builders[i]) == NO_NODE) {
+            result = -1;
+        }
+    }
+
+    for (size_t i = 0; i < ruleCount && result == 0; ++i) {
+        const char *pattern = rules[i].pattern;
+        if (pattern == nullptr) {
+            result = -1;
+            break;
+        }
+
+        // Символы, которые парсер никогда не оставляет в компоненте: шаблон с ними не совпал бы ни с чем
+        // Characters the parser never leaves in the component: a pattern with them could never match
+        struct TrieBuilder *builder;
+        const char *forbidden;
+        int reverse = 0;
+        int foldCase = 0;
+        switch (rules[i].kind) {
+            case URI_FILTER_HOST_SUFFIX:
+                builder = hostSuffix;
+                forbidden = "]:/?#";
+                reverse = 1;
+                foldCase = 1;
+                break;
+            case URI_FILTER_PATH_PREFIX:
+                builder = pathPrefix;
+                forbidden = "?#";
+                break;
+            case URI_FILTER_PATH_CONTAINS:
+                builder = pathContains;
+                forbidden = "?#";
+                break;
+            case URI_FILTER_QUERY_KEY:
+                builder = queryKey;
+                forbidden = "=&#";
+                break;
+            default:
+                result = -1;
+                continue;
+        }
+
+        size_t length = strlen(pattern);
+        if (rules[i].kind == URI_FILTER_HOST_SUFFIX) {
+            // ".example.com", "example.com" и "example.com." означают одно и то же
+            // ".example.com", "example.com" and "example.com." mean the same
+            while (length > 0 && *pattern == '.') {
+                pattern++;
+                length--;
+            }
+            while (length > 0 && pattern[length - 1] == '.') {
+                length--;
+            }
+        }
+
+        if (length == 0 || strcspn(pattern, forbidden) < length) {
+            result = -1;
+        } else {
+            result = builderInsert(builder, pattern, length, reverse, foldCase, i);
+        }
+    }
+
+    if (result == 0) {
+        if (trieFreeze(hostSuffix, &filter->hostSuffix, 0) < 0 ||
+            trieFreeze(pathPrefix, &filter->pathPrefix, 0) < 0 ||
+            trieFreeze(pathContains, &filter->pathContains, 1) < 0 ||
+            trieFreeze(queryKey, &filter->queryKey, 0) < 0) {
+            result = -1;
+        }
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+        builderFree(&builders[i]);
+    }
+
+    if (result < 0) {
+        uriFilterDestroy(filter);
+        return nullptr;
+    }
+    return filter;
+}
+
+/**
+ * @brief Destroys the filter and frees allocated memory.
+ *
+ * @param filter Pointer to the filter to destroy.
+ *
+ * @brief Уничтожает фильтр и освобождает выделенную память.
+ *
+ * @param filter Указатель на фильтр для уничтожения.
+ */
+void uriFilterDestroy(struct UriFilter *filter) {
+    if (filter) {
+        trieFree(&filter->hostSuffix);
+        trieFree(&filter->pathPrefix);
+        trieFree(&filter->pathContains);
+        trieFree(&filter->queryKey);
+        free(filter);
+    }
+}
+
+/**
+ * @brief Creates the per-thread state needed by uriFilterMatch.
+ *
+ * @param filter Pointer to the filter.
+ * @return struct UriFilterScratch* Pointer to the created state, or nullptr if failed.
+ *
+ * @brief Создает состояние потока, необходимое для uriFilterMatch.
+ *
+ * @param filter Указатель на фильтр.
+ * @return struct UriFilterScratch* Указатель на созданное состояние, или nullptr в случае ошибки.
+ */
+struct UriFilterScratch *uriFilterScratchCreate(const struct UriFilter *filter) {
+    if (filter == nullptr) {
+        return nullptr;
+    }
+
+    struct UriFilterScratch *scratch = calloc(1, sizeof(*scratch) + filter->ruleCount * sizeof(scratch->stamps[0]));
+    if (scratch == nullptr) {
+        return nullptr;
+    }
+    scratch->ruleCount = filter->ruleCount;
+    return scratch;
+}
+
+/**
+ * @brief Destroys the per-thread match state.
+ *
+ * @param scratch Pointer to the state to destroy.
+ *
+ * @brief Уничтожает состояние поиска потока.
+ *
+ * @param scratch Указатель на состояние для уничтожения.
+ */
+void uriFilterScratchDestroy(struct UriFilterScratch *scratch) {
+    free(scratch);
+}
+
+/**
+ * @brief Finds the rules matched by a parsed URI.
+ *
+ * @param filter Pointer to the filter.
+ * @param uri Pointer to the Uri structure.
+ * @param scratch State created by uriFilterScratchCreate for this filter; one per thread.
+ * @param matches Array to store the identifiers of matched rules, in no particular order.
+ * @param maxMatches Capacity of the matches array.
+ * @return size_t Number of identifiers stored, 0 if no rule matches.
+ *
+ * @brief Находит правила, которым соответствует разобранный URI.
+ *
+ * @param filter Указатель на фильтр.
+ * @param uri Указатель на структуру Uri.
+ * @param scratch Состояние, созданное uriFilterScratchCreate для этого фильтра; одно на поток.
+ * @param matches Массив для хранения идентификаторов совпавших правил, в произвольном порядке.
+ * @param maxMatches Емкость массива matches.
+ * @return size_t Количество сохраненных идентификаторов, 0 если совпадений нет.
+ */
+size_t uriFilterMatch(const struct UriFilter *filter, const struct Uri *uri, struct UriFilterScratch *scratch, size_t *matches, size_t maxMatches) {
+    if (filter == nullptr || uri == nullptr || scratch == nullptr || scratch->ruleCount < filter->ruleCount ||
+        matches == nullptr || maxMatches == 0) {
+        return 0;
+    }
+
+    // Новое поколение делает все отметки прошлых вызовов устаревшими без очистки
+    // A new generation makes the stamps of past calls stale without clearing them
+    if (++scratch->generation == 0) {
+        memset(scratch->stamps, 0, scratch->ruleCount * sizeof(scratch->stamps[0]));
+        scratch->generation = 1;
+    }
+    struct MatchSink sink = {matches, maxMatches, 0, scratch->stamps, scratch->generation};
+
+    if (uri->host && filter->hostSuffix.nodeCount > 1 && matchHostSuffix(&filter->hostSuffix, uri->host, uri->hostLength, &sink)) {
+        return sink.count;
+    }
+    if (uri->path && filter->pathPrefix.nodeCount > 1 && matchPathPrefix(&filter->pathPrefix, uri->path, uri->pathLength, &sink)) {
+        return sink.count;
+    }
+    if (uri->path && filter->pathContains.nodeCount > 1 && matchPathContains(&filter->pathContains, uri->path, uri->pathLength, &sink)) {
+        return sink.count;
+    }
+    if (uri->query && filter->queryKey.nodeCount > 1) {
+        matchQueryKey(&filter->queryKey, uri->query, uri->queryLength, &sink);
+    }
+    return sink.count;
+}
@@ -0,0 +1,138 @@
+#ifndef URI_FILTER_H
+#define URI_FILTER_H
+
+#include <stddef.h>
+
+#include "uri.h"
+
+/**
+ * @brief Kinds of filter rules.
+ *
+ * @brief Виды правил фильтра.
+ */
+enum UriFilterRuleKind {
+    URI_FILTER_HOST_SUFFIX,   /**< Host equals the pattern or ends with "." + pattern, case-insensitive, trailing dots ignored / Хост равен шаблону или оканчивается на "." + шаблон, без учета регистра, завершающие точки игнорируются */
+    URI_FILTER_PATH_PREFIX,   /**< Path starts with the pattern / Путь начинается с шаблона */
+    URI_FILTER_PATH_CONTAINS, /**< Path contains the pattern / Путь содержит шаблон */
+    URI_FILTER_QUERY_KEY      /**< Query has a parameter with this key / Запрос содержит параметр с этим ключом */
+};
+
+/**
+ * @struct UriFilterRule
+ * @brief A single filter rule. Its identifier is its index in the array
+ * passed to uriFilterCreate.
+ *
+ * @struct UriFilterRule
+ * @brief Одно правило фильтра. Его идентификатор — индекс в массиве,
+ * переданном в uriFilterCreate.
+ */
+struct UriFilterRule {
+    enum UriFilterRuleKind kind; /**< Kind of the rule / Вид правила */
+    const char *pattern;         /**< Pattern string / Строка шаблона */
+};
+
+/**
+ * @struct UriFilter
+ * @brief Compiled set of rules. Immutable after creation, so one filter can
+ * be shared by any number of threads without locking.
+ *
+ * @struct UriFilter
+ * @brief Скомпилированный набор правил. Не изменяется после создания, поэтому
+ * один фильтр может использоваться любым числом потоков без блокировок.
+ */
+struct UriFilter;
+
+/**
+ * @struct UriFilterScratch
+ * @brief Mutable state of uriFilterMatch, sized by the number of rules. Each
+ * thread needs its own; it is reused across calls without reallocation.
+ *
+ * @struct UriFilterScratch
+ * @brief Изменяемое состояние uriFilterMatch, размер которого зависит от количества
+ * правил. Каждому потоку нужно свое; оно используется повторно без перевыделения.
+ */
+struct UriFilterScratch;
+
+/**
+ * @brief Compiles the given rules into a filter.
+ *
+ * @param rules Array of rules.
+ * @param ruleCount Number of rules.
+ * @return struct UriFilter* Pointer to the created filter, or nullptr if a rule is invalid (unknown kind, empty pattern, or a pattern that could never match) or allocation failed.
+ *
+ * @brief Компилирует заданные правила в фильтр.
+ *
+ * @param rules Массив правил.
+ * @param ruleCount Количество правил.
+ * @return struct UriFilter* Указатель на созданный фильтр, или nullptr, если правило некорректно (неизвестный вид, пустой шаблон или шаблон, который никогда не совпал бы) или не удалось выделить память.
+ */
+struct UriFilter *uriFilterCreate(const struct UriFilterRule *rules, size_t ruleCount);
+
+/**
+ * @brief Destroys the filter and frees allocated memory.
+ *
+ * @param filter Pointer to the filter to destroy.
+ *
+ * @brief Уничтожает фильтр и освобождает выделенную память.
+ *
+ * @param filter Указатель на фильтр для уничтожения.
+ */
+void uriFilterDestroy(struct UriFilter *filter);
+
+/**
+ * @brief Creates the per-thread state needed by uriFilterMatch.
+ *
+ * @param filter Pointer to the filter.
+ * @return struct UriFilterScratch* Pointer to the created state, or nullptr if failed.
+ *
+ * @brief Создает состояние потока, необходимое для uriFilterMatch.
+ *
+ * @param filter Указатель на фильтр.
+ * @return struct UriFilterScratch* Указатель на созданное состояние, или nullptr в случае ошибки.
+ */
+struct UriFilterScratch *uriFilterScratchCreate(const struct UriFilter *filter);
+
+/**
+ * @brief Destroys the per-thread match state.
+ *
+ * @param scratch Pointer to the state to destroy.
+ *
+ * @brief Уничтожает состояние поиска потока.
+ *
+ * @param scratch Указатель на состояние для уничтожения.
+ */
+void uriFilterScratchDestroy(struct UriFilterScratch *scratch);
+
+/**
+ * @brief Finds the rules matched by a parsed URI.
+ *
+ * Each component is scanned once and every rule is reported at most once,
+ * so the cost depends on the URI length and the number of distinct matches,
+ * not on the number of rules. Matching stops as soon as maxMatches distinct
+ * rules were found; pass maxMatches 1 to only test whether any rule matches.
+ *
+ * @param filter Pointer to the filter.
+ * @param uri Pointer to the Uri structure.
+ * @param scratch State created by uriFilterScratchCreate for this filter; one per thread.
+ * @param matches Array to store the identifiers of matched rules, in no particular order.
+ * @param maxMatches Capacity of the matches array.
+ * @return size_t Number of identifiers stored, 0 if no rule matches.
+ *
+ * @brief Находит правила, которым соответствует разобранный URI.
+ *
+ * Каждый компонент просматривается один раз и каждое правило сообщается
+ * не более одного раза, поэтому время зависит от длины URI и количества
+ * различных совпадений, а не от количества правил. Поиск прекращается,
+ * как только найдено maxMatches различных правил; передайте maxMatches 1,
+ * чтобы только проверить, совпадает ли хотя бы одно правило.
+ *
+ * @param filter Указатель на фильтр.
+ * @param uri Указатель на структуру Uri.
+ * @param scratch Состояние, созданное uriFilterScratchCreate для этого фильтра; одно на поток.
+ * @param matches Массив для хранения идентификаторов совпавших правил, в произвольном порядке.
+ * @param maxMatches Емкость массива matches.
+ * @return size_t Количество сохраненных идентификаторов, 0 если совпадений нет.
+ */
+size_t uriFilterMatch(const struct UriFilter *filter, const struct Uri *uri, struct UriFilterScratch *scratch, size_t *matches, size_t maxMatches);
+
+#endif // URI_FILTER_H
@@ -0,0 +1,387 @@
+#include "uri_stats.h"
+
+#include <string.h>
+
+#ifdef URI_STATS
+#include <threads.h>
+#endif
+
+#if defined(URI_STATS_CYCLES)
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+static const char *const failureNames[URI_STATS_FAILURE_COUNT] = {
+        "null_input",
+        "missing_scheme",
+        "unterminated_host",
+        "port_range",
+        "out_of_memory"
+};
+
+static const char *const componentNames[URI_STATS_COMPONENT_COUNT] = {
+        "scheme",
+        "user_info",
+        "host",
+        "port",
+        "path",
+        "query",
+        "fragment"
+};
+
+static const char *const stageNames[URI_STATS_STAGE_COUNT] = {
+        "scheme",
+        "authority",
+        "path_query_fragment",
+        "buffer"
+};
+
+#ifdef URI_STATS
+
+static_assert(sizeof(struct UriStats) % sizeof(unsigned long long) == 0, "struct UriStats must consist of counters only");
+
+_Thread_local struct UriStatsBlock uriStatsThread;
+
+static once_flag registryOnce = ONCE_FLAG_INIT;
+static mtx_t registryMutex;
+static tss_t registryKey;
+static struct UriStatsBlock *registryHead;  // Блоки работающих потоков / Blocks of running threads
+static struct UriStats registryRetired;     // Сумма завершившихся потоков / Sum of exited threads
+static int registryReady;                   // Мьютекс и ключ созданы / Mutex and key were created
+
+/**
+ * @brief Copies a thread's counters with relaxed atomic loads.
+ *
+ * @param block Pointer to the thread's block.
+ * @param stats Pointer to store the counters.
+ *
+ * @brief Копирует счетчики потока ослабленными атомарными загрузками.
+ *
+ * @param block Указатель на блок потока.
+ * @param stats Указатель для хранения счетчиков.
+ */
+static void blockLoad(struct UriStatsBlock *block, struct UriStats *stats) {
+    unsigned long long counters[URI_STATS_SLOT_COUNT];
+    for (size_t i = 0; i < URI_STATS_SLOT_COUNT; ++i) {
+        counters[i] = atomic_load_explicit(&block->counters[i], memory_order_relaxed);
+    }
+    memcpy(stats, counters, sizeof(*stats));
+}
+
+/**
+ * @brief Folds the block of an exiting thread into the retired total and unregisters it.
+ *
+ * @param value Pointer to the thread's block.
+ *
+ * @brief Добавляет блок завершающегося потока к сумме завершившихся и снимает его с регистрации.
+ *
+ * @param value Указатель на блок потока.
+ */
+static void registryRetire(void *value) {
+    struct UriStatsBlock *block = value;
+    struct UriStats stats;
+    blockLoad(block, &stats);
+
+    mtx_lock(&registryMutex);
+    uriStatsMerge(&registryRetired, &stats);
+    for (struct UriStatsBlock **link = &registryHead; *link; link = &(*link)->next) {
+        if (*link == block) {
+            *link = block->next;
+            break;
+        }
+    }
+    mtx_unlock(&registryMutex);
+}
+
+/**
+ * @brief Initializes the registry mutex and the thread exit hook.
+ *
+ * @brief Инициализирует мьютекс реестра и обработчик завершения потока.
+ */
+static void registryInit(void) {
+    if (mtx_init(&registryMutex, mtx_plain) != thrd_success) {
+        return;
+    }
+    if (tss_create(&registryKey, registryRetire) != thrd_success) {
+        mtx_destroy(&registryMutex);
+        return;
+    }
+    registryReady = 1;
+}
+
+/**
+ * @brief Adds the calling thread's block to the global list on first use.
+ *
+ * Without the registry or the thread exit hook the block is never linked,
+ * since it could not be unlinked when the thread exits; the thread then
+ * counts into its own storage only.
+ *
+ * @brief Добавляет блок вызывающего потока в глобальный список при первом использовании.
+ *
+ * Без реестра или обработчика завершения потока блок не добавляется в список,
+ * так как его нельзя было бы удалить при завершении потока; тогда поток
+ * ведет счетчики только в собственной памяти.
+ */
+void uriStatsRegister(void) {
+    call_once(&registryOnce, registryInit);
+    uriStatsThread.registered = 1;
+    if (!registryReady || tss_set(registryKey, &uriStatsThread) != thrd_success) {
+        return;
+    }
+    mtx_lock(&registryMutex);
+    uriStatsThread.next = registryHead;
+    registryHead = &uriStatsThread;
+    mtx_unlock(&registryMutex);
+}
+
+/**
+ * @brief Maps a component length to its histogram bucket.
+ *
+ * @param length Component length.
+ * @return size_t Bucket index.
+ *
+ * @brief Сопоставляет длину компонента с корзиной гистограммы.
+ *
+ * @param length Длина компонента.
+ * @return size_t Индекс корзины.
+ */
+size_t uriStatsBucket(size_t length) {
+    size_t bucket = 0;
+    while (length != 0 && bucket < URI_STATS_HISTOGRAM_BUCKETS - 1) {
+        length >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * @brief Reads the cycle counter (nanoseconds where no counter is available).
+ *
+ * @return unsigned long long Current counter value.
+ *
+ * @brief Читает счетчик тактов (наносекунды, если счетчик недоступен).
+ *
+ * @return unsigned long long Текущее значение счетчика.
+ */
+unsigned long long uriStatsCycles(void) {
+#if !defined(URI_STATS_CYCLES)
+    return 0;
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    unsigned long long value;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (unsigned long long)now.tv_sec * 1000000000ULL + (unsigned long long)now.tv_nsec;
+#endif
+}
+
+#endif // URI_STATS
+
+/**
+ * @brief Tells whether statistics were compiled into the library.
+ *
+ * @return int 1 if URI_STATS is enabled, 0 otherwise.
+ *
+ * @brief Сообщает, включена ли статистика при сборке библиотеки.
+ *
+ * @return int 1, если URI_STATS включен, иначе 0.
+ */
+int uriStatsEnabled(void) {
+#ifdef URI_STATS
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Copies the calling thread's counters. Use uriStatsSnapshotAll to
+ * read the counters of all threads.
+ *
+ * @param stats Pointer to store the snapshot.
+ *
+ * @brief Копирует счетчики вызывающего потока. Для чтения счетчиков всех
+ * потоков используйте uriStatsSnapshotAll.
+ *
+ * @param stats Указатель для хранения снимка.
+ */
+void uriStatsSnapshot(struct UriStats *stats) {
+    if (stats == nullptr) {
+        return;
+    }
+#ifdef URI_STATS
+    blockLoad(&uriStatsThread, stats);
+#else
+    memset(stats, 0, sizeof(*stats));
+#endif
+}
+
+/**
+ * @brief Sums the counters of all threads, including threads that have exited.
+ *
+ * @param stats Pointer to store the snapshot.
+ *
+ * @brief Суммирует счетчики всех потоков, включая завершившиеся.
+ *
+ * @param stats Указатель для хранения снимка.
+ */
+void uriStatsSnapshotAll(struct UriStats *stats) {
+    if (stats == nullptr) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+#ifdef URI_STATS
+    call_once(&registryOnce, registryInit);
+    if (!registryReady) {
+        return;
+    }
+    mtx_lock(&registryMutex);
+    *stats = registryRetired;
+    for (struct UriStatsBlock *block = registryHead; block; block = block->next) {
+        struct UriStats thread;
+        blockLoad(block, &thread);
+        uriStatsMerge(stats, &thread);
+    }
+    mtx_unlock(&registryMutex);
+#endif
+}
+
+/**
+ * @brief Resets the calling thread's counters to zero. Counters of other
+ * threads and of exited threads are not affected.
+ *
+ * @brief Обнуляет счетчики вызывающего потока. Счетчики других потоков
+ * и завершившихся потоков не изменяются.
+ */
+void uriStatsReset(void) {
+#ifdef URI_STATS
+    for (size_t i = 0; i < URI_STATS_SLOT_COUNT; ++i) {
+        atomic_store_explicit(&uriStatsThread.counters[i], 0, memory_order_relaxed);
+    }
+#endif
+}
+
+/**
+ * @brief Adds the counters of one snapshot to another.
+ *
+ * @param destination Snapshot to accumulate into.
+ * @param source Snapshot to add.
+ *
+ * @brief Прибавляет счетчики одного снимка к другому.
+ *
+ * @param destination Снимок, в который выполняется накопление.
+ * @param source Добавляемый снимок.
+ */
+void uriStatsMerge(struct UriStats *destination, const struct UriStats *source) {
+    if (destination == nullptr || source == nullptr) {
+        return;
+    }
+
+    destination->parses += source->parses;
+    destination->successes += source->successes;
+    for (size_t i = 0; i < URI_STATS_FAILURE_COUNT; ++i) {
+        destination->failures[i] += source->failures[i];
+    }
+    destination->createAllocations += source->createAllocations;
+    destination->createBytes += source->createBytes;
+    destination->fullUriAllocations += source->fullUriAllocations;
+    destination->fullUriBytes += source->fullUriBytes;
+    for (size_t i = 0; i < URI_STATS_COMPONENT_COUNT; ++i) {
+        for (size_t j = 0; j < URI_STATS_HISTOGRAM_BUCKETS; ++j) {
+            destination->componentLengths[i][j] += source->componentLengths[i][j];
+        }
+    }
+    for (size_t i = 0; i < URI_STATS_STAGE_COUNT; ++i) {
+        destination->stageRuns[i] += source->stageRuns[i];
+        destination->stageCycles[i] += source->stageCycles[i];
+    }
+}
+
+/**
+ * @brief Writes a snapshot as human-readable text.
+ *
+ * @param stream Output stream.
+ * @param stats Snapshot to write.
+ * @return int 0 on success, -1 on failure.
+ *
+ * @brief Записывает снимок в виде читаемого текста.
+ *
+ * @param stream Поток вывода.
+ * @param stats Записываемый снимок.
+ * @return int 0 при успешном выполнении, -1 при ошибке.
+ */
+int uriStatsDumpText(FILE *stream, const struct UriStats *stats) {
+    if (stream == nullptr || stats == nullptr) {
+        return -1;
+    }
+
+    fprintf(stream, "parses: %llu\n", stats->parses);
+    fprintf(stream, "successes: %llu\n", stats->successes);
+    for (size_t i = 0; i < URI_STATS_FAILURE_COUNT; ++i) {
+        fprintf(stream, "failures.%s: %llu\n", failureNames[i], stats->failures[i]);
+    }
+    fprintf(stream, "create.allocations: %llu\n", stats->createAllocations);
+    fprintf(stream, "create.bytes: %llu\n", stats->createBytes);
+    fprintf(stream, "full_uri.allocations: %llu\n", stats->fullUriAllocations);
+    fprintf(stream, "full_uri.bytes: %llu\n", stats->fullUriBytes);
+    for (size_t i = 0; i < URI_STATS_COMPONENT_COUNT; ++i) {
+        fprintf(stream, "length.%s:", componentNames[i]);
+        for (size_t j = 0; j < URI_STATS_HISTOGRAM_BUCKETS; ++j) {
+            fprintf(stream, " %llu", stats->componentLengths[i][j]);
+        }
+        fputc('\n', stream);
+    }
+    for (size_t i = 0; i < URI_STATS_STAGE_COUNT; ++i) {
+        fprintf(stream, "stage.%s: runs=%llu cycles=%llu\n", stageNames[i], stats->stageRuns[i], stats->stageCycles[i]);
+    }
+
+    return ferror(stream) ? -1 : 0;
+}
+
+/**
+ * @brief Writes a snapshot as a single JSON object.
+ *
+ * @param stream Output stream.
+ * @param stats Snapshot to write.
+ * @return int 0 on success, -1 on failure.
+ *
+ * @brief Записывает снимок в виде одного JSON-объекта.
+ *
+ * @param stream Поток вывода.
+ * @param stats Записываемый снимок.
+ * @return int 0 при успешном выполнении, -1 при ошибке.
+ */
+int uriStatsDumpJson(FILE *stream, const struct UriStats *stats) {
+    if (stream == nullptr || stats == nullptr) {
+        return -1;
+    }
+
+    fprintf(stream, "{\"parses\":%llu,\"successes\":%llu,\"failures\":{", stats->parses, stats->successes);
+    for (size_t i = 0; i < URI_STATS_FAILURE_COUNT; ++i) {
+        fprintf(stream, "%s\"%s\":%llu", i ? "," : "", failureNames[i], stats->failures[i]);
+    }
+    fprintf(stream, "},\"create\":{\"allocations\":%llu,\"bytes\":%llu}", stats->createAllocations, stats->createBytes);
+    fprintf(stream, ",\"full_uri\":{\"allocations\":%llu,\"bytes\":%llu}", stats->fullUriAllocations, stats->fullUriBytes);
+    fputs(",\"lengths\":{", stream);
+    for (size_t i = 0; i < URI_STATS_COMPONENT_COUNT; ++i) {
+        fprintf(stream, "%s\"%s\":[", i ? "," : "", componentNames[i]);
+        for (size_t j = 0; j < URI_STATS_HISTOGRAM_BUCKETS; ++j) {
+            fprintf(stream, "%s%llu", j ? "," : "", stats->componentLengths[i][j]);
+        }
+        fputc(']', stream);
+    }
+    fputs("},\"stages\":{", stream);
+    for (size_t i = 0; i < URI_STATS_STAGE_COUNT; ++i) {
+        fprintf(stream, "%s\"%s\":{\"runs\":%llu,\"cycles\":%llu}", i ? "," : "", stageNames[i], stats->stageRuns[i], stats->stageCycles[i]);
+    }
+    fputs("}}\n", stream);
+
+    return ferror(stream) ? -1 : 0;
+}
@@ -0,0 +1,252 @@
+#ifndef URI_STATS_H
+#define URI_STATS_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * Parser statistics are compiled in only when URI_STATS is defined
+ * (CMake option URI_ENABLE_STATS). Per-stage cycle counts additionally
+ * require URI_STATS_CYCLES (CMake option URI_ENABLE_STATS_CYCLES).
+ * Without URI_STATS the hooks in uri.c expand to nothing and the API below
+ * reports zeroed counters.
+ *
+ * Статистика парсера компилируется только при определенном URI_STATS
+ * (опция CMake URI_ENABLE_STATS). Счетчики тактов по этапам дополнительно
+ * требуют URI_STATS_CYCLES (опция CMake URI_ENABLE_STATS_CYCLES).
+ * Без URI_STATS хуки в uri.c раскрываются в пустоту, а API ниже
+ * возвращает нулевые счетчики.
+ */
+
+#define URI_STATS_HISTOGRAM_BUCKETS 16
+
+/**
+ * @brief Reasons for which uriCreate can fail.
+ *
+ * @brief Причины, по которым uriCreate может завершиться ошибкой.
+ */
+enum UriStatsFailure {
+    URI_STATS_FAILURE_NULL_INPUT,        /**< uriString was nullptr / uriString равен nullptr */
+    URI_STATS_FAILURE_MISSING_SCHEME,    /**< No ':' after the scheme / Нет ':' после схемы */
+    URI_STATS_FAILURE_UNTERMINATED_HOST, /**< '[' without closing ']' / '[' без закрывающей ']' */
+    URI_STATS_FAILURE_PORT_RANGE,        /**< Port above 65535 / Порт больше 65535 */
+    URI_STATS_FAILURE_OUT_OF_MEMORY,     /**< Allocation failed / Ошибка выделения памяти */
+    URI_STATS_FAILURE_COUNT
+};
+
+/**
+ * @brief URI components tracked by the length histograms.
+ *
+ * @brief Компоненты URI, для которых строятся гистограммы длин.
+ */
+enum UriStatsComponent {
+    URI_STATS_COMPONENT_SCHEME,
+    URI_STATS_COMPONENT_USER_INFO,
+    URI_STATS_COMPONENT_HOST,
+    URI_STATS_COMPONENT_PORT,
+    URI_STATS_COMPONENT_PATH,
+    URI_STATS_COMPONENT_QUERY,
+    URI_STATS_COMPONENT_FRAGMENT,
+    URI_STATS_COMPONENT_COUNT
+};
+
+/**
+ * @brief Parser stages timed when URI_STATS_CYCLES is enabled.
+ *
+ * @brief Этапы парсера, время которых измеряется при включенном URI_STATS_CYCLES.
+ */
+enum UriStatsStage {
+    URI_STATS_STAGE_SCHEME,
+    URI_STATS_STAGE_AUTHORITY,
+    URI_STATS_STAGE_PATH_QUERY_FRAGMENT,
+    URI_STATS_STAGE_BUFFER,
+    URI_STATS_STAGE_COUNT
+};
+
+/**
+ * @struct UriStats
+ * @brief Parser counters. Histogram bucket 0 counts empty components,
+ * bucket i counts lengths in [2^(i-1), 2^i), the last bucket is open-ended.
+ *
+ * @struct UriStats
+ * @brief Счетчики парсера. Корзина 0 гистограммы считает пустые компоненты,
+ * корзина i считает длины в [2^(i-1), 2^i), последняя корзина не ограничена сверху.
+ */
+struct UriStats {
+    unsigned long long parses;            /**< uriCreate calls / Вызовы uriCreate */
+    unsigned long long successes;         /**< Successful parses / Успешные разборы */
+    unsigned long long failures[URI_STATS_FAILURE_COUNT]; /**< Failures by reason / Ошибки по причинам */
+    unsigned long long createAllocations; /**< Allocations in uriCreate / Выделения памяти в uriCreate */
+    unsigned long long createBytes;       /**< Bytes allocated in uriCreate / Байт выделено в uriCreate */
+    unsigned long long fullUriAllocations;/**< Allocations in uriGetFullUri / Выделения памяти в uriGetFullUri */
+    unsigned long long fullUriBytes;      /**< Bytes allocated in uriGetFullUri / Байт выделено в uriGetFullUri */
+    unsigned long long componentLengths[URI_STATS_COMPONENT_COUNT][URI_STATS_HISTOGRAM_BUCKETS]; /**< Length histograms / Гистограммы длин */
+    unsigned long long stageRuns[URI_STATS_STAGE_COUNT];   /**< Stage executions / Запуски этапов */
+    unsigned long long stageCycles[URI_STATS_STAGE_COUNT]; /**< Cycles spent per stage / Такты по этапам */
+};
+
+/**
+ * @brief Tells whether statistics were compiled into the library.
+ *
+ * @return int 1 if URI_STATS is enabled, 0 otherwise.
+ *
+ * @brief Сообщает, включена ли статистика при сборке библиотеки.
+ *
+ * @return int 1, если URI_STATS включен, иначе 0.
+ */
+int uriStatsEnabled(void);
+
+/**
+ * @brief Copies the calling thread's counters. Use uriStatsSnapshotAll to
+ * read the counters of all threads.
+ *
+ * @param stats Pointer to store the snapshot.
+ *
+ * @brief Копирует счетчики вызывающего потока. Для чтения счетчиков всех
+ * потоков используйте uriStatsSnapshotAll.
+ *
+ * @param stats Указатель для хранения снимка.
+ */
+void uriStatsSnapshot(struct UriStats *stats);
+
+/**
+ * @brief Sums the counters of all threads, including threads that have exited.
+ *
+ * Can be called from any thread, e.g. a metrics collector. Counters of
+ * running threads are read while they are being updated, so the sum is
+ * consistent per counter but not across counters. If the registry could not
+ * be created, the snapshot is zero.
+ *
+ * @param stats Pointer to store the snapshot.
+ *
+ * @brief Суммирует счетчики всех потоков, включая завершившиеся.
+ *
+ * Может вызываться из любого потока, например из сборщика метрик. Счетчики
+ * работающих потоков читаются во время их обновления, поэтому сумма
+ * согласована для каждого счетчика, но не между счетчиками. Если реестр
+ * не удалось создать, снимок нулевой.
+ *
+ * @param stats Указатель для хранения снимка.
+ */
+void uriStatsSnapshotAll(struct UriStats *stats);
+
+/**
+ * @brief Resets the calling thread's counters to zero. Counters of other
+ * threads and of exited threads are not affected.
+ *
+ * @brief Обнуляет счетчики вызывающего потока. Счетчики других потоков
+ * и завершившихся потоков не изменяются.
+ */
+void uriStatsReset(void);
+
+/**
+ * @brief Adds the counters of one snapshot to another.
+ *
+ * @param destination Snapshot to accumulate into.
+ * @param source Snapshot to add.
+ *
+ * @brief Прибавляет счетчики одного снимка к другому.
+ *
+ * @param destination Снимок, в который выполняется накопление.
+ * @param source Добавляемый снимок.
+ */
+void uriStatsMerge(struct UriStats *destination, const struct UriStats *source);
+
+/**
+ * @brief Writes a snapshot as human-readable text.
+ *
+ * @param stream Output stream.
+ * @param stats Snapshot to write.
+ * @return int 0 on success, -1 on failure.
+ *
+ * @brief Записывает снимок в виде читаемого текста.
+ *
+ * @param stream Поток вывода.
+ * @param stats Записываемый снимок.
+ * @return int 0 при успешном выполнении, -1 при ошибке.
+ */
+int uriStatsDumpText(FILE *stream, const struct UriStats *stats);
+
+/**
+ * @brief Writes a snapshot as a single JSON object.
+ *
+ * @param stream Output stream.
+ * @param stats Snapshot to write.
+ * @return int 0 on success, -1 on failure.
+ *
+ * @brief Записывает снимок в виде одного JSON-объекта.
+ *
+ * @param stream Поток вывода.
+ * @param stats Записываемый снимок.
+ * @return int 0 при успешном выполнении, -1 при ошибке.
+ */
+int uriStatsDumpJson(FILE *stream, const struct UriStats *stats);
+
+#ifdef URI_STATS
+
+#include <stdatomic.h>
+
+// Hooks used by uri.c / Хуки, используемые в uri.c
+
+#define URI_STATS_SLOT_COUNT (sizeof(struct UriStats) / sizeof(unsigned long long))
+#define URI_STATS_SLOT(field) (offsetof(struct UriStats, field) / sizeof(unsigned long long))
+
+/**
+ * @struct UriStatsBlock
+ * @brief Counters of one thread, laid out like struct UriStats. Only the owning
+ * thread writes them; a collector reads them with relaxed atomic loads.
+ *
+ * @struct UriStatsBlock
+ * @brief Счетчики одного потока, расположенные как в struct UriStats. Пишет их
+ * только поток-владелец; сборщик читает их ослабленными атомарными загрузками.
+ */
+struct UriStatsBlock {
+    _Atomic unsigned long long counters[URI_STATS_SLOT_COUNT]; /**< Counters / Счетчики */
+    struct UriStatsBlock *next; /**< Next registered block / Следующий зарегистрированный блок */
+    int registered;             /**< Block is in the global list / Блок находится в глобальном списке */
+};
+
+extern _Thread_local struct UriStatsBlock uriStatsThread;
+
+void uriStatsRegister(void);
+size_t uriStatsBucket(size_t length);
+unsigned long long uriStatsCycles(void);
+
+static inline void uriStatsAdd(size_t slot, unsigned long long value) {
+    if (!uriStatsThread.registered) {
+        uriStatsRegister();
+    }
+    // Единственный писатель: чтение-изменение-запись без блокирующей инструкции
+    // Single writer: read-modify-write without a locked instruction
+    _Atomic unsigned long long *counter = &uriStatsThread.counters[slot];
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+#define URI_STATS_ADD(field, value) uriStatsAdd(URI_STATS_SLOT(field), (value))
+#define URI_STATS_FAIL(reason) uriStatsAdd(URI_STATS_SLOT(failures) + (reason), 1)
+#define URI_STATS_LENGTH(component, length) \
+    uriStatsAdd(URI_STATS_SLOT(componentLengths) + (component) * URI_STATS_HISTOGRAM_BUCKETS + uriStatsBucket(length), 1)
+
+#ifdef URI_STATS_CYCLES
+#define URI_STATS_STAGE_BEGIN(name) unsigned long long uriStatsStart_##name = uriStatsCycles()
+#define URI_STATS_STAGE_END(name, stage)                                                           \
+    do {                                                                                           \
+        uriStatsAdd(URI_STATS_SLOT(stageRuns) + (stage), 1);                                       \
+        uriStatsAdd(URI_STATS_SLOT(stageCycles) + (stage), uriStatsCycles() - uriStatsStart_##name); \
+    } while (0)
+#else
+#define URI_STATS_STAGE_BEGIN(name) ((void)0)
+#define URI_STATS_STAGE_END(name, stage) uriStatsAdd(URI_STATS_SLOT(stageRuns) + (stage), 1)
+#endif
+
+#else
+
+#define URI_STATS_ADD(field, value) ((void)0)
+#define URI_STATS_FAIL(reason) ((void)0)
+#define URI_STATS_LENGTH(component, length) ((void)0)
+#define URI_STATS_STAGE_BEGIN(name) ((void)0)
+#define URI_STATS_STAGE_END(name, stage) ((void)0)
+
+#endif // URI_STATS
+
+#endif // URI_STATS_H